@@ -0,0 +1,142 @@
+// Main-thread side of the worker-hosted renderer (render_worker.js).
+//
+//   const host = createRenderHost(canvas, { script: 'ground_renderer.js' });
+//   await host.ready;
+//   host.setTexture(rgbaBytes, 256, 256);
+//   // every input tick:
+//   host.setCamera(posX, posY, dirX, dirY, planeX, planeY);
+//
+//   // with { script: 'game_logic.js' }, obstacles are drawn over the ground:
+//   host.setWorld({ worldW: 256, worldH: 256, viewDist: 40 });
+//   host.loadSprite(rgbaBytes, 64, 64, 0);
+//   host.setObstacles(records, count);   // _add_obstacles_batch layout
+//
+// The canvas is transferred to the worker, which owns the module, renders
+// into linear memory and presents with putImageData on the OffscreenCanvas.
+// Frames never cross threads. Camera updates go through a SharedArrayBuffer
+// ring when the page is cross-origin isolated, otherwise as small messages.
+//
+// Calls made before `ready` settles are queued by the worker. A failed load
+// rejects `ready`; every error, including later ones from texture uploads or
+// the render loop, is also passed to options.onError (console.error when
+// none is given).
+(function () {
+    'use strict';
+
+    const CAMERA_FLOATS = 6;
+    const RING_SLOTS = 8;
+
+    // A private ArrayBuffer holding exactly the bytes of `data` (an
+    // ArrayBuffer or any view), safe to transfer to the worker.
+    function transferCopy(data) {
+        if (ArrayBuffer.isView(data)) {
+            return new Uint8Array(data.buffer, data.byteOffset, data.byteLength).slice().buffer;
+        }
+        return data.slice(0);
+    }
+
+    function createRenderHost(canvas, options) {
+        const opts = options || {};
+        const base = new URL(opts.baseUrl || '.', document.baseURI);
+        const worker = new Worker(new URL('render_worker.js', base));
+        const offscreen = canvas.transferControlToOffscreen();
+
+        let ring = null, seq = null, slots = null;
+        if (typeof SharedArrayBuffer !== 'undefined' && self.crossOriginIsolated) {
+            ring = new SharedArrayBuffer(4 + RING_SLOTS * CAMERA_FLOATS * 4);
+            seq = new Int32Array(ring, 0, 1);
+            slots = new Float32Array(ring, 4);
+        }
+
+        let resolveReady, rejectReady;
+        let settled = false;
+        const ready = new Promise((resolve, reject) => {
+            resolveReady = resolve;
+            rejectReady = reject;
+        });
+        const onError = opts.onError || ((err) => console.error('[render worker]', err));
+        function fail(err) {
+            if (!settled) {
+                settled = true;
+                rejectReady(err);
+            }
+            onError(err);
+        }
+        worker.onmessage = (e) => {
+            const msg = e.data;
+            if (msg.type === 'ready') {
+                settled = true;
+                resolveReady();
+            } else if (msg.type === 'error') {
+                fail(new Error(msg.message));
+            } else if (msg.type === 'frame' && opts.onFrame) {
+                opts.onFrame(msg);
+            }
+        };
+        worker.onerror = (e) => {
+            e.preventDefault();
+            fail(new Error(e.message || 'render worker failed to start'));
+        };
+
+        worker.postMessage({
+            type: 'init',
+            script: new URL(opts.script || 'ground_renderer.js', base).href,
+            canvas: offscreen,
+            ring,
+            kernel: opts.kernel,
+            extraArgs: opts.extraArgs,
+        }, [offscreen]);
+
+        return {
+            ready,
+            // Pixels are tightly packed RGBA; buffers are copied once so
+            // the caller keeps its own.
+            setTexture(pixels, width, height) {
+                const copy = transferCopy(pixels);
+                worker.postMessage({ type: 'texture', pixels: copy, width, height }, [copy]);
+            },
+            setWorld(world) {
+                worker.postMessage(Object.assign({}, world, { type: 'world' }));
+            },
+            // `records` holds `count` 24-byte obstacles; `append` keeps the
+            // ones already loaded.
+            setObstacles(records, count, append) {
+                const data = transferCopy(records);
+                worker.postMessage({ type: 'obstacles', data, count, append: !!append }, [data]);
+            },
+            loadSprite(pixels, width, height, spriteType) {
+                const copy = transferCopy(pixels);
+                worker.postMessage({ type: 'sprite', pixels: copy, width, height, spriteType }, [copy]);
+            },
+            clearSprites() {
+                worker.postMessage({ type: 'clearSprites' });
+            },
+            setCamera(posX, posY, dirX, dirY, planeX, planeY) {
+                if (!ring) {
+                    worker.postMessage({ type: 'camera', posX, posY, dirX, dirY, planeX, planeY });
+                    return;
+                }
+                const next = Atomics.load(seq, 0) + 1;
+                const o = ((next - 1) % RING_SLOTS) * CAMERA_FLOATS;
+                slots[o] = posX;
+                slots[o + 1] = posY;
+                slots[o + 2] = dirX;
+                slots[o + 3] = dirY;
+                slots[o + 4] = planeX;
+                slots[o + 5] = planeY;
+                Atomics.store(seq, 0, next);
+            },
+            resize(width, height) {
+                worker.postMessage({ type: 'resize', width, height });
+            },
+            // Lets the worker free its buffers, then terminates it in case it
+            // is stuck in a kernel or never finished loading.
+            destroy() {
+                worker.postMessage({ type: 'stop' });
+                worker.terminate();
+            },
+        };
+    }
+
+    self.createRenderHost = createRenderHost;
+})();
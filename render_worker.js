@@ -0,0 +1,287 @@
+// Dedicated worker that hosts a wasm module and presents frames straight
+// to an OffscreenCanvas: the ground kernel, then (with game_logic.js) the
+// obstacle sprites composited over it. Started by render_host.js; see there
+// for the main-thread API.
+//
+// Messages in:
+//   init      { script, canvas, ring?, kernel, extraArgs }
+//   texture   { pixels (transferred ArrayBuffer), width, height }
+//   camera    { posX, posY, dirX, dirY, planeX, planeY }  (no-SAB fallback)
+//   resize    { width, height }
+//   world     { worldW, worldH, viewDist?, eyeHeight?, focal?, horizon? }
+//   obstacles { data (transferred ArrayBuffer), count, append? }
+//   sprite    { pixels (transferred ArrayBuffer), width, height, spriteType }
+//   clearSprites
+//   stop
+// world, obstacles and sprite need game_logic.js. Obstacle records are the
+// 24-byte layout _add_obstacles_batch reads (f32 x, y, radius, height;
+// i32 sprite type, tag). The obstacle pass runs once a world size is set
+// and obstacles are loaded; focal and horizon default to the frame height
+// and half of it.
+// Messages out:
+//   ready, frame { seq, ms }, error { message }
+//
+// Everything lives inside an IIFE: ground_renderer.js is imported as a
+// classic script and declares globals such as Module and out.
+(function () {
+    'use strict';
+
+    const CAMERA_FLOATS = 6;
+    const OBSTACLE_BYTES = 24;
+
+    let wasm = null;
+    let ctx = null;
+    let kernel = '_render_ground_quality';
+    let extraArgs = [];
+    let ring = null;            // { seq: Int32Array, slots: Float32Array, count }
+    let camera = null;          // latest camera when no ring is shared
+    let tex = 0, texW = 0, texH = 0;
+    let out = 0, outW = 0, outH = 0;
+    let layer = null;           // 2d context of the obstacle OffscreenCanvas
+    let layerOut = 0;
+    let world = null;           // { worldW, worldH, viewDist, eyeHeight, focal, horizon }
+    let obstacleCount = 0;
+    let running = false;
+    let lastSeq = -1;
+    let state = 'loading';      // loading -> ready | failed
+    const queued = [];          // messages that arrived before init finished
+
+    importScripts('wasm_loader.js');
+
+    // `script` is the glue URL (…/ground_renderer.js or …/game_logic.js);
+    // the .wasm next to it is compiled and cached by wasm_loader.js.
+    async function loadModule(script) {
+        const name = new URL(script).pathname.split('/').pop().replace(/\.js$/, '');
+        const { Module } = await self.WasmLoader.load(name, {
+            baseUrl: script,
+            moduleArgs: { print: () => {} },
+        });
+        return Module;
+    }
+
+    function allocFrame(width, height) {
+        if (out) wasm._free(out);
+        out = wasm._malloc(width * height * 4);
+        outW = width;
+        outH = height;
+        ctx.canvas.width = width;
+        ctx.canvas.height = height;
+        if (layer) {
+            wasm._free(layerOut);
+            layerOut = wasm._malloc(width * height * 4);
+            layer.canvas.width = width;
+            layer.canvas.height = height;
+        }
+    }
+
+    function requireObstacles(what) {
+        if (typeof wasm._render_obstacles_to_buffer !== 'function') {
+            throw new Error(`${what} needs game_logic.js, the loaded module has no obstacle exports`);
+        }
+        if (!layer) {
+            layer = new OffscreenCanvas(outW, outH).getContext('2d');
+            layerOut = wasm._malloc(outW * outH * 4);
+        }
+    }
+
+    // Copies a transferred buffer into a temporary wasm allocation for the
+    // duration of `fn(ptr)`; the module keeps its own copy.
+    function withBytes(buffer, bytes, fn) {
+        const ptr = wasm._malloc(bytes);
+        try {
+            wasm.HEAPU8.set(new Uint8Array(buffer, 0, bytes), ptr);
+            return fn(ptr);
+        } finally {
+            wasm._free(ptr);
+        }
+    }
+
+    function checkLength(what, buffer, bytes, detail) {
+        if (buffer.byteLength < bytes) {
+            throw new Error(`${what} has ${buffer.byteLength} bytes, ${detail} needs ${bytes}`);
+        }
+    }
+
+    // Sprites for the visible obstacles into the layer buffer, then drawn
+    // over the ground; untouched pixels stay transparent.
+    function renderObstacles(cam) {
+        const bytes = outW * outH * 4;
+        wasm.HEAPU8.fill(0, layerOut, layerOut + bytes);
+        const angle = Math.atan2(cam.dirY, cam.dirX);
+        const fov = 2 * Math.atan(Math.hypot(cam.planeX, cam.planeY) / Math.hypot(cam.dirX, cam.dirY));
+        wasm._render_obstacles_to_buffer(layerOut, outW, outH,
+            cam.posX, cam.posY, world.eyeHeight, angle, cam.posX, cam.posY, world.eyeHeight,
+            fov, world.viewDist, world.worldW, world.worldH,
+            world.focal || outH, world.horizon || outH / 2, 0, 0, outW, outH);
+        const pixels = new Uint8ClampedArray(wasm.HEAPU8.buffer, layerOut, bytes);
+        layer.putImageData(new ImageData(pixels, outW, outH), 0, 0);
+        ctx.drawImage(layer.canvas, 0, 0);
+    }
+
+    // Seqlock read of the newest camera slot; retries if the writer lapped us.
+    function readRing() {
+        for (;;) {
+            const seq = Atomics.load(ring.seq, 0);
+            if (seq === 0) return null;
+            const base = ((seq - 1) % ring.count) * CAMERA_FLOATS;
+            const s = ring.slots;
+            const cam = {
+                seq,
+                posX: s[base], posY: s[base + 1],
+                dirX: s[base + 2], dirY: s[base + 3],
+                planeX: s[base + 4], planeY: s[base + 5],
+            };
+            if (Atomics.load(ring.seq, 0) - seq < ring.count - 1) return cam;
+        }
+    }
+
+    function tick() {
+        if (!running) return;
+        const cam = ring ? readRing() : camera;
+        if (cam && tex && out && cam.seq !== lastSeq) {
+            lastSeq = cam.seq;
+            const t0 = performance.now();
+            try {
+                wasm[kernel](out, tex, outW, outH, texW, texH,
+                    cam.posX, cam.posY, cam.dirX, cam.dirY, cam.planeX, cam.planeY,
+                    ...extraArgs);
+                // View straight into linear memory; putImageData copies once.
+                const pixels = new Uint8ClampedArray(wasm.HEAPU8.buffer, out, outW * outH * 4);
+                ctx.putImageData(new ImageData(pixels, outW, outH), 0, 0);
+                if (world && obstacleCount > 0) renderObstacles(cam);
+            } catch (err) {
+                running = false;
+                reportError(err);
+                return;
+            }
+            postMessage({ type: 'frame', seq: cam.seq, ms: performance.now() - t0 });
+        }
+        requestAnimationFrame(tick);
+    }
+
+    const handlers = {
+        async init(msg) {
+            wasm = await loadModule(msg.script);
+            ctx = msg.canvas.getContext('2d');
+            kernel = msg.kernel || kernel;
+            extraArgs = msg.extraArgs || [];
+            if (msg.ring) {
+                ring = {
+                    seq: new Int32Array(msg.ring, 0, 1),
+                    slots: new Float32Array(msg.ring, 4),
+                    count: (msg.ring.byteLength - 4) / (CAMERA_FLOATS * 4),
+                };
+            }
+            allocFrame(msg.canvas.width, msg.canvas.height);
+            running = true;
+            requestAnimationFrame(tick);
+        },
+        texture(msg) {
+            const bytes = msg.width * msg.height * 4;
+            checkLength('texture', msg.pixels, bytes, `${msg.width}x${msg.height} RGBA`);
+            if (tex) wasm._free(tex);
+            tex = wasm._malloc(bytes);
+            wasm.HEAPU8.set(new Uint8Array(msg.pixels, 0, bytes), tex);
+            texW = msg.width;
+            texH = msg.height;
+            lastSeq = -1;
+        },
+        camera(msg) {
+            camera = { ...msg, seq: (camera ? camera.seq : 0) + 1 };
+        },
+        resize(msg) {
+            allocFrame(msg.width, msg.height);
+            lastSeq = -1;
+        },
+        world(msg) {
+            requireObstacles('world');
+            if (!(msg.worldW > 0 && msg.worldH > 0)) {
+                throw new Error('world needs a positive worldW and worldH');
+            }
+            world = {
+                worldW: msg.worldW,
+                worldH: msg.worldH,
+                viewDist: msg.viewDist || 32,
+                eyeHeight: msg.eyeHeight || 0,
+                focal: msg.focal || 0,
+                horizon: msg.horizon || 0,
+            };
+            lastSeq = -1;
+        },
+        obstacles(msg) {
+            requireObstacles('obstacles');
+            const bytes = msg.count * OBSTACLE_BYTES;
+            checkLength('obstacle batch', msg.data, bytes, `${msg.count} records`);
+            if (!msg.append) wasm._init_obstacles();
+            const expected = (msg.append ? wasm._get_obstacle_count() : 0) + msg.count;
+            withBytes(msg.data, bytes, (ptr) => wasm._add_obstacles_batch(ptr, msg.count));
+            obstacleCount = wasm._get_obstacle_count();
+            if (obstacleCount < expected) {
+                reportError(`obstacle table is full, kept ${obstacleCount} of ${expected} records`);
+            }
+            lastSeq = -1;
+        },
+        sprite(msg) {
+            requireObstacles('sprite');
+            const bytes = msg.width * msg.height * 4;
+            checkLength('sprite', msg.pixels, bytes, `${msg.width}x${msg.height} RGBA`);
+            const index = withBytes(msg.pixels, bytes,
+                (ptr) => wasm._load_sprite(ptr, msg.width, msg.height, msg.spriteType));
+            if (index < 0) throw new Error(`sprite type ${msg.spriteType} rejected, the sprite table is full`);
+            lastSeq = -1;
+        },
+        clearSprites() {
+            requireObstacles('clearSprites');
+            wasm._cleanup_sprites();
+            lastSeq = -1;
+        },
+        stop() {
+            running = false;
+            if (out) wasm._free(out);
+            if (tex) wasm._free(tex);
+            if (layerOut) wasm._free(layerOut);
+            out = tex = layerOut = 0;
+            close();
+        },
+    };
+
+    function reportError(err) {
+        postMessage({ type: 'error', message: String(err && err.message || err) });
+    }
+
+    function dispatch(msg) {
+        const handler = handlers[msg.type];
+        if (!handler) {
+            reportError(`unknown message type: ${msg.type}`);
+            return;
+        }
+        try {
+            handler(msg);
+        } catch (err) {
+            reportError(err);
+        }
+    }
+
+    // Messages other than init are held until the module is loaded, then
+    // replayed in order; after a failed init they are rejected.
+    onmessage = (e) => {
+        const msg = e.data;
+        if (msg.type === 'init') {
+            handlers.init(msg).then(() => {
+                state = 'ready';
+                postMessage({ type: 'ready' });
+                queued.splice(0).forEach(dispatch);
+            }, (err) => {
+                state = 'failed';
+                queued.length = 0;
+                reportError(err);
+            });
+        } else if (state === 'loading') {
+            queued.push(msg);
+        } else if (state === 'failed') {
+            reportError(`renderer not initialized, dropped "${msg.type}"`);
+        } else {
+            dispatch(msg);
+        }
+    };
+})();
@@ -0,0 +1,291 @@
+#!/usr/bin/env node
+// Headless benchmark for the published wasm modules.
+//
+//   node tools/bench.js [--frames N] [--warmup N] [--perf-args a,b,c,d,e,f]
+//                       [--out file.json]
+//
+// Loads both modules through wasm_loader.js and drives the exports along a
+// canned camera path over synthetic textures, sprites and obstacle sets.
+// Results are per-call percentiles, printed as JSON so two builds can be
+// diffed:
+//   _render_ground_quality / _render_ground_performance   ns/pixel
+//   _process_visible_obstacles / _check_collision         ns/obstacle
+//   _render_obstacles_to_buffer                 ns/pixel and ns/obstacle
+//
+// Argument layouts, as read from the exports' function bodies (there are no
+// sources in this tree):
+//   ground kernels  (out, tex, width, height, tex_w, tex_h,
+//                    posX, posY, dirX, dirY, planeX, planeY)
+//                   _render_ground_performance appends five i32 and one f32
+//                   mode/block parameters; they are passed verbatim from
+//                   --perf-args (default 0,0,0,0,0,0).
+//   obstacle record 24 bytes: f32 x, y, radius, height; i32 sprite type
+//                   and tag (_load_sprite's last argument is the type).
+//   visibility      (camX, camY, unused, angle, refX, refY, height, fov,
+//                   view_dist, world_w, world_h, out[20000 * 6 f32])
+//   collision       (unused, unused, radius, height, x, y, world_w, world_h)
+//   obstacle layer  (out, width, height, camX, camY, camZ, angle, refX, refY,
+//                   height, fov, view_dist, world_w, world_h, focal,
+//                   horizon, view_x, view_y, view_w, view_h)
+//
+// The obstacle sweep covers 1k and 10k obstacles only: the table inside
+// game_logic.wasm is a fixed 10000-entry array, so 100k would need a
+// rebuilt module.
+'use strict';
+
+const fs = require('fs');
+const { performance } = require('perf_hooks');
+const { loadModule, moduleNames } = require('./load_modules');
+
+const RESOLUTIONS = [
+    { name: '720p', width: 1280, height: 720 },
+    { name: '1080p', width: 1920, height: 1080 },
+    { name: '4k', width: 3840, height: 2160 },
+];
+const TEXTURES = [256, 1024];
+const OBSTACLE_COUNTS = [1000, 10000];
+const OBSTACLE_FLOATS = 6;
+const VISIBLE_MAX = 20000;
+const SPRITE_SIZE = 64;
+const SPRITE_TYPES = 4;
+const WORLD = 256;
+const VIEW_DIST = 64;
+
+function parseArgs(argv) {
+    const opts = { frames: 60, warmup: 5, perfArgs: [0, 0, 0, 0, 0, 0], out: null };
+    for (let i = 0; i < argv.length; i++) {
+        const key = argv[i];
+        if (key === '--frames') opts.frames = parseInt(argv[++i], 10);
+        else if (key === '--warmup') opts.warmup = parseInt(argv[++i], 10);
+        else if (key === '--perf-args') opts.perfArgs = argv[++i].split(',').map(Number);
+        else if (key === '--out') opts.out = argv[++i];
+        else throw new Error(`unknown argument: ${key}`);
+    }
+    if (opts.perfArgs.length !== 6 || opts.perfArgs.some(Number.isNaN)) {
+        throw new Error('--perf-args needs six comma-separated numbers');
+    }
+    return opts;
+}
+
+// Deterministic RGBA texture: coarse checker plus a gradient, so samples
+// along any view direction touch varied cache lines.
+function fillTexture(heap, ptr, size) {
+    for (let y = 0; y < size; y++) {
+        for (let x = 0; x < size; x++) {
+            const o = ptr + (y * size + x) * 4;
+            const checker = ((x >> 4) ^ (y >> 4)) & 1;
+            heap[o] = checker ? 200 : (x * 255 / size) | 0;
+            heap[o + 1] = checker ? 180 : (y * 255 / size) | 0;
+            heap[o + 2] = ((x ^ y) & 0xff);
+            heap[o + 3] = 255;
+        }
+    }
+}
+
+// Camera path: forward motion with a slow turn, matching a player walking
+// and steering. Same sequence for every run.
+function cameraAt(frame) {
+    const angle = frame * 0.02;
+    const dirX = Math.cos(angle);
+    const dirY = Math.sin(angle);
+    const fov = 0.66;
+    return {
+        posX: 32 + frame * 0.25 * dirX,
+        posY: 32 + frame * 0.25 * dirY,
+        dirX,
+        dirY,
+        planeX: -dirY * fov,
+        planeY: dirX * fov,
+    };
+}
+
+function percentile(sorted, p) {
+    const idx = Math.min(sorted.length - 1, Math.floor(p * sorted.length));
+    return sorted[idx];
+}
+
+function summarize(samples, units) {
+    const sorted = samples.slice().sort((a, b) => a - b);
+    const r = (v) => Math.round(v * 1000) / 1000;
+    return {
+        p50: r(percentile(sorted, 0.5) / units),
+        p90: r(percentile(sorted, 0.9) / units),
+        p99: r(percentile(sorted, 0.99) / units),
+        min: r(sorted[0] / units),
+    };
+}
+
+// Times `fn(frame, camera)` over the warmup + measured frames and returns
+// the measured samples in nanoseconds.
+function timeFrames(opts, fn) {
+    const samples = [];
+    for (let f = 0; f < opts.warmup + opts.frames; f++) {
+        const c = cameraAt(f);
+        const t0 = performance.now();
+        fn(f, c);
+        const t1 = performance.now();
+        if (f >= opts.warmup) samples.push((t1 - t0) * 1e6);
+    }
+    return samples;
+}
+
+function benchGround(Module, fnName, res, texSize, opts) {
+    const fn = Module[fnName];
+    const pixels = res.width * res.height;
+    const tex = Module._malloc(texSize * texSize * 4);
+    const out = Module._malloc(pixels * 4);
+    // _malloc may grow memory; read HEAPU8 afterwards.
+    fillTexture(Module.HEAPU8, tex, texSize);
+
+    const extra = fnName === '_render_ground_performance' ? opts.perfArgs : [];
+    const samples = timeFrames(opts, (f, c) => fn(out, tex, res.width, res.height, texSize, texSize,
+        c.posX, c.posY, c.dirX, c.dirY, c.planeX, c.planeY, ...extra));
+
+    Module._free(out);
+    Module._free(tex);
+    return { ns_per_pixel: summarize(samples, pixels) };
+}
+
+// Replaces the module's obstacle table with `count` obstacles scattered
+// over the world in one _add_obstacles_batch call.
+function seedObstacles(Module, count) {
+    const ptr = Module._malloc(count * OBSTACLE_FLOATS * 4);
+    const f32 = new Float32Array(Module.HEAPU8.buffer, ptr, count * OBSTACLE_FLOATS);
+    const i32 = new Int32Array(Module.HEAPU8.buffer, ptr, count * OBSTACLE_FLOATS);
+    let seed = 12345;
+    const rand = () => ((seed = (seed * 1103515245 + 12345) >>> 0) / 4294967296);
+    for (let i = 0; i < count; i++) {
+        const o = i * OBSTACLE_FLOATS;
+        f32[o] = rand() * WORLD;
+        f32[o + 1] = rand() * WORLD;
+        f32[o + 2] = 0.25 + rand() * 0.5;
+        f32[o + 3] = 1 + rand();
+        i32[o + 4] = i % SPRITE_TYPES;
+        i32[o + 5] = i % SPRITE_TYPES;
+    }
+    Module._init_obstacles();
+    Module._add_obstacles_batch(ptr, count);
+    Module._free(ptr);
+    const stored = Module._get_obstacle_count();
+    if (stored !== count) throw new Error(`module kept ${stored} of ${count} obstacles`);
+}
+
+function loadSprites(Module) {
+    const bytes = SPRITE_SIZE * SPRITE_SIZE * 4;
+    const ptr = Module._malloc(bytes);
+    Module._cleanup_sprites();
+    for (let type = 0; type < SPRITE_TYPES; type++) {
+        fillTexture(Module.HEAPU8, ptr, SPRITE_SIZE);
+        Module._load_sprite(ptr, SPRITE_SIZE, SPRITE_SIZE, type);
+    }
+    Module._free(ptr);
+}
+
+const angleOf = (c) => Math.atan2(c.dirY, c.dirX);
+const fovOf = (c) => 2 * Math.atan(Math.hypot(c.planeX, c.planeY) / Math.hypot(c.dirX, c.dirY));
+
+function benchVisible(Module, count, opts) {
+    const out = Module._malloc(VISIBLE_MAX * OBSTACLE_FLOATS * 4);
+    let visible = 0;
+    const samples = timeFrames(opts, (f, c) => {
+        visible = Module._process_visible_obstacles(c.posX, c.posY, 0, angleOf(c),
+            c.posX, c.posY, 0, fovOf(c), VIEW_DIST, WORLD, WORLD, out);
+    });
+    Module._free(out);
+    return { ns_per_obstacle: summarize(samples, count), visible_last: visible };
+}
+
+// Probes a point with zero height: every obstacle is tested, so the time
+// is the full scan rather than an early hit.
+function benchCollision(Module, count, opts) {
+    let hits = 0;
+    const samples = timeFrames(opts, (f, c) => {
+        hits += Module._check_collision(0, 0, 0.1, 0, c.posX, c.posY, WORLD, WORLD);
+    });
+    return { ns_per_obstacle: summarize(samples, count), hits };
+}
+
+function benchObstacleLayer(Module, res, count, opts) {
+    const pixels = res.width * res.height;
+    const out = Module._malloc(pixels * 4);
+    const samples = timeFrames(opts, (f, c) => {
+        Module.HEAPU8.fill(0, out, out + pixels * 4);
+        Module._render_obstacles_to_buffer(out, res.width, res.height,
+            c.posX, c.posY, 0, angleOf(c), c.posX, c.posY, 0, fovOf(c), VIEW_DIST,
+            WORLD, WORLD, res.height, res.height / 2, 0, 0, res.width, res.height);
+    });
+    Module._free(out);
+    return {
+        ns_per_pixel: summarize(samples, pixels),
+        ns_per_obstacle: summarize(samples, count),
+    };
+}
+
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const modules = {};
+    for (const name of moduleNames) modules[name] = await loadModule(name);
+
+    const results = [];
+    for (const [moduleName, Module] of Object.entries(modules)) {
+        for (const fnName of ['_render_ground_quality', '_render_ground_performance']) {
+            for (const res of RESOLUTIONS) {
+                for (const texSize of TEXTURES) {
+                    const stats = benchGround(Module, fnName, res, texSize, opts);
+                    results.push({
+                        module: moduleName,
+                        export: fnName,
+                        resolution: res.name,
+                        texture: `${texSize}x${texSize}`,
+                        frames: opts.frames,
+                        ...(fnName === '_render_ground_performance' ? { perf_args: opts.perfArgs } : {}),
+                        ...stats,
+                    });
+                    process.stderr.write(`${moduleName} ${fnName} ${res.name} tex${texSize}: ` +
+                        `${stats.ns_per_pixel.p50} ns/px (p50)\n`);
+                }
+            }
+        }
+    }
+
+    // Obstacle exports exist only in game_logic.
+    const logic = modules.game_logic;
+    loadSprites(logic);
+    for (const count of OBSTACLE_COUNTS) {
+        seedObstacles(logic, count);
+        const runs = [
+            ['_process_visible_obstacles', null, benchVisible(logic, count, opts)],
+            ['_check_collision', null, benchCollision(logic, count, opts)],
+            ...RESOLUTIONS.map((res) =>
+                ['_render_obstacles_to_buffer', res.name, benchObstacleLayer(logic, res, count, opts)]),
+        ];
+        for (const [fnName, resolution, stats] of runs) {
+            results.push({
+                module: 'game_logic',
+                export: fnName,
+                obstacles: count,
+                ...(resolution ? { resolution } : {}),
+                frames: opts.frames,
+                ...stats,
+            });
+            process.stderr.write(`game_logic ${fnName} ${resolution ? resolution + ' ' : ''}n=${count}: ` +
+                `${stats.ns_per_obstacle.p50} ns/obstacle (p50)\n`);
+        }
+    }
+    logic._init_obstacles();
+    logic._cleanup_sprites();
+
+    const report = {
+        node: process.version,
+        date: new Date().toISOString(),
+        results,
+    };
+    const json = JSON.stringify(report, null, 2);
+    if (opts.out) fs.writeFileSync(opts.out, json + '\n');
+    else process.stdout.write(json + '\n');
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
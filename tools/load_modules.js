@@ -0,0 +1,20 @@
+// Node-side loaders for the published wasm modules, shared by the tools.
+// Loading itself goes through wasm_loader.js, the same path pages use.
+'use strict';
+
+const path = require('path');
+const WasmLoader = require('../wasm_loader');
+
+const ROOT = path.resolve(__dirname, '..');
+const MODULES = ['game_logic', 'ground_renderer'];
+
+async function loadModule(name) {
+    if (!MODULES.includes(name)) throw new Error(`unknown module: ${name}`);
+    const { Module } = await WasmLoader.load(name, {
+        baseUrl: ROOT,
+        moduleArgs: { print: () => {}, printErr: () => {} },
+    });
+    return Module;
+}
+
+module.exports = { ROOT, loadModule, moduleNames: MODULES };
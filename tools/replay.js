@@ -0,0 +1,104 @@
+#!/usr/bin/env node
+// Re-executes a trace captured with wasm_trace.js against the wasm module
+// it was recorded from, headlessly.
+//
+//   node tools/replay.js trace.bin [--repeat N] [--out file.json]
+//
+// Allocations and buffer contents are reproduced exactly, so each call sees
+// the same inputs it saw in production. Every repeat runs in a freshly
+// loaded module, because obstacles and sprites persist inside the module.
+// Traces with pointers that were not mapped at capture time are refused.
+// Wall time is reported per export as total and percentiles over all calls
+// and repeats.
+'use strict';
+
+const fs = require('fs');
+const { performance } = require('perf_hooks');
+const { readTrace } = require('../wasm_trace');
+const { loadModule } = require('./load_modules');
+
+function parseArgs(argv) {
+    const opts = { trace: null, repeat: 1, out: null };
+    for (let i = 0; i < argv.length; i++) {
+        const key = argv[i];
+        if (key === '--repeat') opts.repeat = parseInt(argv[++i], 10);
+        else if (key === '--out') opts.out = argv[++i];
+        else if (!opts.trace) opts.trace = key;
+        else throw new Error(`unknown argument: ${key}`);
+    }
+    if (!opts.trace) throw new Error('usage: replay.js trace.bin [--repeat N] [--out file.json]');
+    return opts;
+}
+
+function replayOnce(Module, records, timings) {
+    const ptrs = new Map();
+    const blobs = new Map();
+    for (const rec of records) {
+        switch (rec.tag) {
+        case 'malloc':
+            ptrs.set(rec.alloc, Module._malloc(rec.size));
+            break;
+        case 'free':
+            Module._free(ptrs.get(rec.alloc));
+            ptrs.delete(rec.alloc);
+            break;
+        case 'blob':
+            blobs.set(rec.blob, rec.bytes);
+            break;
+        case 'load':
+            Module.HEAPU8.set(blobs.get(rec.blob), ptrs.get(rec.alloc));
+            break;
+        case 'call': {
+            const fn = Module[rec.name];
+            if (typeof fn !== 'function') throw new Error(`module has no export ${rec.name}`);
+            const args = rec.args.map((a) =>
+                a.kind === 'ref' ? ptrs.get(a.alloc) + a.offset : a.value);
+            const t0 = performance.now();
+            fn(...args);
+            const t1 = performance.now();
+            if (!timings.has(rec.name)) timings.set(rec.name, []);
+            timings.get(rec.name).push((t1 - t0) * 1e6);
+            break;
+        }
+        }
+    }
+    // Release whatever the trace left allocated so repeats start clean.
+    for (const ptr of ptrs.values()) Module._free(ptr);
+}
+
+function summarize(samples) {
+    const sorted = samples.slice().sort((a, b) => a - b);
+    const at = (p) => Math.round(sorted[Math.min(sorted.length - 1, Math.floor(p * sorted.length))]);
+    return {
+        calls: sorted.length,
+        total_ns: Math.round(sorted.reduce((s, v) => s + v, 0)),
+        p50_ns: at(0.5),
+        p90_ns: at(0.9),
+        p99_ns: at(0.99),
+    };
+}
+
+async function main() {
+    const opts = parseArgs(process.argv.slice(2));
+    const { module, records } = readTrace(new Uint8Array(fs.readFileSync(opts.trace)));
+    const unresolved = records.filter((r) => r.tag === 'call' && r.args.some((a) => a.kind === 'unresolved'));
+    if (unresolved.length) {
+        const names = [...new Set(unresolved.map((r) => r.name))].join(', ');
+        throw new Error(`${opts.trace}: ${unresolved.length} calls (${names}) use memory allocated ` +
+            'before capture started; re-capture with the trace attached at load time');
+    }
+
+    const timings = new Map();
+    for (let i = 0; i < opts.repeat; i++) replayOnce(await loadModule(module), records, timings);
+
+    const exports = {};
+    for (const [name, samples] of timings) exports[name] = summarize(samples);
+    const json = JSON.stringify({ trace: opts.trace, module, repeat: opts.repeat, exports }, null, 2);
+    if (opts.out) fs.writeFileSync(opts.out, json + '\n');
+    else process.stdout.write(json + '\n');
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exit(1);
+});
@@ -0,0 +1,181 @@
+// Loader for the two wasm modules with streaming compilation and one
+// compile per module per page (or Node process).
+//
+//   const { Module, report } = await WasmLoader.load('game_logic');
+//   ... first frame drawn ...
+//   report.firstFrame();   // logs and returns time-to-first-frame in ms
+//
+//   // both modules, fetched and compiled in parallel:
+//   const [ground, logic] = await WasmLoader.loadAll(['ground_renderer', 'game_logic']);
+//
+// The .wasm is compiled with WebAssembly.compileStreaming when the server
+// sends application/wasm, otherwise with compile() over the one fetched
+// body. The emscripten glue is handed the compiled module via
+// Module.instantiateWasm, so its own readAsync/ArrayBuffer path is never
+// taken.
+//
+// Passing { trace: {...attachTrace options} } attaches wasm_trace.js before
+// the module is handed out and returns it as `trace`, which is the only way
+// to capture a session that obstacles and sprites can be replayed from.
+// render_worker.js and the Node tools (tools/load_modules.js) load through
+// here as well, so there is one place that knows how to start each glue.
+//
+// Cache: compiled modules are kept in memory by URL, so a second load() or
+// a worker that shares the loader does not compile again. Across page
+// loads there is no cache of our own: browsers cannot store a compiled
+// WebAssembly.Module in IndexedDB, and compileStreaming over an HTTP-cached
+// response already hits the engine's code cache. report.cacheHit is true
+// only when this page had compiled (or was compiling) the module before.
+(function () {
+    'use strict';
+
+    const IS_NODE = typeof process === 'object' && process.versions && process.versions.node;
+
+    const compiled = new Map();     // url -> Promise of WebAssembly.Module
+
+    const now = () => (typeof performance !== 'undefined' ? performance : require('perf_hooks').performance).now();
+
+    async function compileBrowser(url) {
+        const response = await fetch(url, { credentials: 'same-origin' });
+        if (!response.ok) throw new Error(`failed to fetch ${url}: ${response.status}`);
+        // compileStreaming rejects any other MIME type; compile the same
+        // body instead of fetching it twice.
+        const type = response.headers.get('Content-Type') || '';
+        if (typeof WebAssembly.compileStreaming === 'function' && type.startsWith('application/wasm')) {
+            return WebAssembly.compileStreaming(response);
+        }
+        return WebAssembly.compile(await response.arrayBuffer());
+    }
+
+    function compileNode(file) {
+        return WebAssembly.compile(require('fs').readFileSync(file));
+    }
+
+    // Fetches and compiles once per URL and reports whether an earlier load
+    // had already started it, plus how long this caller waited. Failed
+    // attempts are forgotten so the next load retries.
+    function compile(url) {
+        const cacheHit = compiled.has(url);
+        if (!cacheHit) {
+            compiled.set(url, (IS_NODE ? compileNode : compileBrowser)(url).catch((err) => {
+                compiled.delete(url);
+                throw err;
+            }));
+        }
+        const t0 = now();
+        return compiled.get(url).then((module) => ({ module, cacheHit, compileMs: now() - t0 }));
+    }
+
+    function loadScript(url) {
+        if (typeof importScripts === 'function') {
+            importScripts(url);
+            return Promise.resolve();
+        }
+        return new Promise((resolve, reject) => {
+            const s = document.createElement('script');
+            s.src = url;
+            s.onload = resolve;
+            s.onerror = () => reject(new Error(`failed to load ${url}`));
+            document.head.appendChild(s);
+        });
+    }
+
+    function resolveUrl(file, baseUrl) {
+        if (IS_NODE) return require('path').resolve(baseUrl || __dirname, file);
+        const base = baseUrl || (typeof document !== 'undefined' ? document.baseURI : self.location.href);
+        return new URL(file, base).href;
+    }
+
+    // Starts the emscripten runtime for `name` on a precompiled module. An
+    // instantiation failure (e.g. an import mismatch) rejects the result;
+    // the glue itself would otherwise wait forever.
+    function startRuntime(name, scriptUrl, compiled, moduleArgs) {
+        let instantiateFailed;
+        const failed = new Promise((resolve, reject) => { instantiateFailed = reject; });
+        const args = Object.assign({}, moduleArgs, {
+            instantiateWasm(imports, receiveInstance) {
+                WebAssembly.instantiate(compiled, imports)
+                    .then((instance) => receiveInstance(instance, compiled))
+                    .catch(instantiateFailed);
+                return {};
+            },
+        });
+        return Promise.race([failed, runScript(name, scriptUrl, args)]);
+    }
+
+    function runScript(name, scriptUrl, args) {
+        if (name === 'game_logic') {
+            if (IS_NODE) return require(scriptUrl)(args);
+            return loadScript(scriptUrl).then(() => createModule(args));
+        }
+
+        // ground_renderer.js is not modularized and reads a global Module.
+        return new Promise((resolve, reject) => {
+            args.onRuntimeInitialized = () => resolve(args);
+            if (IS_NODE) {
+                const src = require('fs').readFileSync(scriptUrl, 'utf8');
+                new Function('Module', 'require', '__filename', '__dirname', src)(
+                    args, require, scriptUrl, require('path').dirname(scriptUrl));
+                return;
+            }
+            self.Module = args;
+            loadScript(scriptUrl).catch(reject);
+        });
+    }
+
+    // `t0` is when loading began from the caller's point of view; readyMs
+    // and firstFrameMs are measured from it.
+    async function loadFrom(t0, name, opts, compiled) {
+        const t1 = now();
+        const Module = await startRuntime(name, resolveUrl(`${name}.js`, opts.baseUrl), compiled.module, opts.moduleArgs);
+        const t2 = now();
+
+        const report = {
+            module: name,
+            cacheHit: compiled.cacheHit,
+            compileMs: compiled.compileMs,
+            instantiateMs: t2 - t1,
+            readyMs: t2 - t0,
+            firstFrameMs: null,
+            firstFrame() {
+                if (report.firstFrameMs === null) {
+                    report.firstFrameMs = now() - t0;
+                    (opts.onReport || ((r) => console.log(`[wasm] ${r.module}: first frame ` +
+                        `${r.firstFrameMs.toFixed(1)} ms (compile ${r.compileMs.toFixed(1)} ms, ` +
+                        `cache ${r.cacheHit ? 'hit' : 'miss'})`)))(report);
+                }
+                return report.firstFrameMs;
+            },
+        };
+        // Tracing has to start before the caller touches the module, so
+        // obstacles and sprites loaded later are part of the trace.
+        let trace = null;
+        if (opts.trace) {
+            const WasmTrace = IS_NODE ? require('./wasm_trace') : self.WasmTrace;
+            if (!WasmTrace) throw new Error('trace option needs wasm_trace.js loaded first');
+            trace = WasmTrace.attachTrace(Module, Object.assign({ module: name }, opts.trace));
+        }
+        return { Module, report, trace };
+    }
+
+    async function load(name, options) {
+        const opts = options || {};
+        const t0 = now();
+        return loadFrom(t0, name, opts, await compile(resolveUrl(`${name}.wasm`, opts.baseUrl)));
+    }
+
+    // Fetches and compiles several modules concurrently. Runtimes are started
+    // one after another because ground_renderer.js uses the global Module.
+    async function loadAll(names, options) {
+        const opts = options || {};
+        const t0 = now();
+        const modules = await Promise.all(names.map((name) => compile(resolveUrl(`${name}.wasm`, opts.baseUrl))));
+        const results = [];
+        for (let i = 0; i < names.length; i++) results.push(await loadFrom(t0, names[i], opts, modules[i]));
+        return results;
+    }
+
+    const api = { load, loadAll };
+    if (typeof exports === 'object' && typeof module === 'object') module.exports = api;
+    else self.WasmLoader = api;
+})();
@@ -0,0 +1,358 @@
+// Call trace capture for the wasm modules.
+//
+//   const trace = attachTrace(Module);
+//   ... run frames as usual ...
+//   const bytes = trace.stop();   // Uint8Array, replay with tools/replay.js
+//
+// Every exported "_name" function with a known wasm signature is wrapped.
+// Allocations made through _malloc/_free are tracked, and a pointer argument
+// is recorded as (allocation, offset) instead of a raw address; scalar
+// arguments are always recorded as values. A pointer that does not resolve
+// to an allocation made while tracing is recorded as unresolved, reported
+// with a warning, and makes tools/replay.js refuse the trace.
+//
+// Capture has to start before the module is given any state: obstacles
+// (_init_obstacles/_add_obstacles_batch), sprites (_load_sprite) and the
+// buffers later calls point at. Attach right after loading, e.g. with
+// WasmLoader.load(name, { trace: {} }), rather than mid-session.
+// Before each call, the contents of every referenced allocation are
+// snapshotted. Identical snapshots are stored once, so static textures and
+// sprite data cost a single copy per trace. Arguments that an export only
+// writes through (the ground kernels' output frame by default) are not
+// snapshotted; more can be listed with the writeOnly option, e.g.
+//   { writeOnly: { _my_export: [0] } }
+// Exports missing from SIGNATURES can be described with the signatures
+// option ({ _name: 'pif' }); any others are left unwrapped.
+//
+// Trace layout (little endian):
+//   "WTRC" u32 version, str module
+//   records, each starting with a u8 tag:
+//     MALLOC u32 alloc, u32 size
+//     FREE   u32 alloc
+//     BLOB   u32 blob, u32 length, bytes
+//     LOAD   u32 alloc, u32 blob        contents of alloc before next CALL
+//     CALL   str name, u8 argc, args    arg: u8 kind, then
+//                                         i32: i32 | f64: f64 |
+//                                         ref: u32 alloc, u32 offset |
+//                                         unresolved: u32 address
+//   str = u16 length + UTF-8 bytes
+(function () {
+    'use strict';
+
+    const MAGIC = 0x43525457; // "WTRC"
+    const VERSION = 2;
+
+    const TAG_MALLOC = 1;
+    const TAG_FREE = 2;
+    const TAG_BLOB = 3;
+    const TAG_LOAD = 4;
+    const TAG_CALL = 5;
+
+    const ARG_I32 = 0;
+    const ARG_F64 = 1;
+    const ARG_REF = 2;
+    const ARG_UNRESOLVED = 3;
+
+    // Parameter types of the exports shipped in game_logic.wasm and
+    // ground_renderer.wasm, read from their type sections: 'p' is an i32
+    // used as a pointer by the function body, 'i' any other i32, 'f' f32.
+    const SIGNATURES = {
+        _test_wasm: '',
+        _render_ground_quality: 'ppiiiiffffff',
+        _render_ground_performance: 'ppiiiiffffffiiiiif',
+        _test_obstacle_wasm: '',
+        _init_obstacles: '',
+        _add_obstacles_batch: 'pi',
+        _process_visible_obstacles: 'fffffffffffp',
+        _get_obstacle_count: '',
+        _check_collision: 'ffffffff',
+        _load_sprite: 'piii',
+        _cleanup_sprites: '',
+        _render_obstacles_to_buffer: 'piifffffffffffffffff',
+    };
+
+    // Argument indices each export only writes through.
+    const WRITE_ONLY = {
+        _render_ground_quality: [0],
+        _render_ground_performance: [0],
+        _process_visible_obstacles: [11],
+        _render_obstacles_to_buffer: [0],
+    };
+
+    class Writer {
+        constructor() {
+            this.buf = new Uint8Array(1 << 16);
+            this.view = new DataView(this.buf.buffer);
+            this.len = 0;
+        }
+        reserve(n) {
+            if (this.len + n <= this.buf.length) return;
+            let size = this.buf.length * 2;
+            while (size < this.len + n) size *= 2;
+            const next = new Uint8Array(size);
+            next.set(this.buf.subarray(0, this.len));
+            this.buf = next;
+            this.view = new DataView(next.buffer);
+        }
+        u8(v) { this.reserve(1); this.buf[this.len++] = v; }
+        u16(v) { this.reserve(2); this.view.setUint16(this.len, v, true); this.len += 2; }
+        u32(v) { this.reserve(4); this.view.setUint32(this.len, v >>> 0, true); this.len += 4; }
+        i32(v) { this.reserve(4); this.view.setInt32(this.len, v | 0, true); this.len += 4; }
+        f64(v) { this.reserve(8); this.view.setFloat64(this.len, v, true); this.len += 8; }
+        bytes(b) { this.reserve(b.length); this.buf.set(b, this.len); this.len += b.length; }
+        str(s) {
+            const b = new TextEncoder().encode(s);
+            this.u16(b.length);
+            this.bytes(b);
+        }
+        finish() { return this.buf.slice(0, this.len); }
+    }
+
+    // FNV-1a over the snapshot plus its length, used only to find duplicate
+    // blobs; collisions are resolved by a byte compare.
+    function hashBytes(b) {
+        let h = 0x811c9dc5;
+        for (let i = 0; i < b.length; i++) {
+            h ^= b[i];
+            h = Math.imul(h, 0x01000193);
+        }
+        return (h ^ b.length) >>> 0;
+    }
+
+    function sameBytes(a, b) {
+        if (a.length !== b.length) return false;
+        for (let i = 0; i < a.length; i++) if (a[i] !== b[i]) return false;
+        return true;
+    }
+
+    function attachTrace(Module, options) {
+        const opts = options || {};
+        const signatures = Object.assign({}, SIGNATURES, opts.signatures);
+        const writeOnly = Object.assign({}, WRITE_ONLY, opts.writeOnly);
+        const out = new Writer();
+        out.u32(MAGIC);
+        out.u32(VERSION);
+        // Only game_logic carries the obstacle exports.
+        out.str(opts.module ||
+            (typeof Module._init_obstacles === 'function' ? 'game_logic' : 'ground_renderer'));
+
+        const live = new Map();      // ptr -> { id, size }
+        const blobs = new Map();     // hash -> [{ id, bytes }]
+        const lastLoad = new Map();  // alloc id -> blob id
+        const originals = {};
+        const unwrapped = [];
+        const unresolved = new Map();  // export name -> count
+        let nextAlloc = 0;
+        let nextBlob = 0;
+        let active = true;
+
+        function findAlloc(ptr) {
+            if (live.has(ptr)) return { alloc: live.get(ptr), offset: 0 };
+            for (const [base, alloc] of live) {
+                if (ptr > base && ptr < base + alloc.size) {
+                    return { alloc, offset: ptr - base };
+                }
+            }
+            return null;
+        }
+
+        function internBlob(bytes) {
+            const h = hashBytes(bytes);
+            const bucket = blobs.get(h) || [];
+            for (const entry of bucket) {
+                if (sameBytes(entry.bytes, bytes)) return entry.id;
+            }
+            const id = nextBlob++;
+            const copy = bytes.slice();
+            bucket.push({ id, bytes: copy });
+            blobs.set(h, bucket);
+            out.u8(TAG_BLOB);
+            out.u32(id);
+            out.u32(copy.length);
+            out.bytes(copy);
+            return id;
+        }
+
+        function wrapMalloc(fn) {
+            return function (size) {
+                const ptr = fn(size);
+                if (active && ptr) {
+                    const alloc = { id: nextAlloc++, size: size >>> 0 };
+                    live.set(ptr, alloc);
+                    out.u8(TAG_MALLOC);
+                    out.u32(alloc.id);
+                    out.u32(alloc.size);
+                }
+                return ptr;
+            };
+        }
+
+        function wrapFree(fn) {
+            return function (ptr) {
+                const alloc = live.get(ptr);
+                if (active && alloc) {
+                    live.delete(ptr);
+                    lastLoad.delete(alloc.id);
+                    out.u8(TAG_FREE);
+                    out.u32(alloc.id);
+                }
+                return fn(ptr);
+            };
+        }
+
+        function wrapExport(name, fn, sig) {
+            return function () {
+                if (!active) return fn.apply(this, arguments);
+                const args = [];
+                const refs = new Set();
+                const reads = new Set();
+                const outputs = writeOnly[name] || [];
+                for (let i = 0; i < arguments.length; i++) {
+                    const v = arguments[i];
+                    if (sig[i] === 'f') {
+                        args.push({ kind: ARG_F64, value: +v });
+                        continue;
+                    }
+                    if (sig[i] === 'i') {
+                        args.push({ kind: ARG_I32, value: v | 0 });
+                        continue;
+                    }
+                    const ptr = v >>> 0;
+                    const hit = ptr ? findAlloc(ptr) : null;
+                    if (hit) {
+                        args.push({ kind: ARG_REF, alloc: hit.alloc.id, offset: hit.offset });
+                        refs.add(hit.alloc);
+                        if (!outputs.includes(i)) reads.add(hit.alloc);
+                    } else if (!ptr) {
+                        args.push({ kind: ARG_I32, value: 0 });
+                    } else {
+                        args.push({ kind: ARG_UNRESOLVED, value: ptr });
+                        const seen = unresolved.get(name) || 0;
+                        if (!seen) {
+                            console.warn(`[wasm trace] ${name} argument ${i} points at memory ` +
+                                'allocated before tracing started; the trace cannot be replayed');
+                        }
+                        unresolved.set(name, seen + 1);
+                    }
+                }
+                const heap = Module.HEAPU8;
+                for (const [base, alloc] of live) {
+                    if (!reads.has(alloc)) continue;
+                    const blob = internBlob(heap.subarray(base, base + alloc.size));
+                    if (lastLoad.get(alloc.id) === blob) continue;
+                    lastLoad.set(alloc.id, blob);
+                    out.u8(TAG_LOAD);
+                    out.u32(alloc.id);
+                    out.u32(blob);
+                }
+                out.u8(TAG_CALL);
+                out.str(name);
+                out.u8(args.length);
+                for (const a of args) {
+                    out.u8(a.kind);
+                    if (a.kind === ARG_I32) out.i32(a.value);
+                    else if (a.kind === ARG_F64) out.f64(a.value);
+                    else if (a.kind === ARG_UNRESOLVED) out.u32(a.value);
+                    else { out.u32(a.alloc); out.u32(a.offset); }
+                }
+                const result = fn.apply(this, arguments);
+                // Calls may write through the pointers they were given;
+                // force a fresh snapshot the next time they are referenced.
+                for (const alloc of refs) lastLoad.delete(alloc.id);
+                return result;
+            };
+        }
+
+        for (const name of Object.keys(Module)) {
+            const fn = Module[name];
+            if (typeof fn !== 'function' || name[0] !== '_' || name[1] === '_') continue;
+            originals[name] = fn;
+            if (name === '_malloc') Module[name] = wrapMalloc(fn);
+            else if (name === '_free') Module[name] = wrapFree(fn);
+            else if (name in signatures) Module[name] = wrapExport(name, fn, signatures[name]);
+            else unwrapped.push(name);
+        }
+        if (unwrapped.length) {
+            console.warn(`[wasm trace] no signature, not traced: ${unwrapped.join(', ')}`);
+        }
+        // Sprites cannot be queried, but obstacles can: a non-empty table
+        // means capture started mid-session and replay would miss it.
+        if (originals._get_obstacle_count && originals._get_obstacle_count() > 0) {
+            console.warn('[wasm trace] obstacles were added before tracing started; ' +
+                'attach at load time so replay sees the same state');
+        }
+
+        return {
+            // Restores the original exports and returns the encoded trace.
+            stop() {
+                active = false;
+                Object.assign(Module, originals);
+                return out.finish();
+            },
+            get size() { return out.len; },
+            // Pointer arguments that could not be mapped, per export.
+            get unresolved() { return new Map(unresolved); },
+        };
+    }
+
+    class Reader {
+        constructor(bytes) {
+            this.buf = bytes;
+            this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+            this.pos = 0;
+        }
+        get done() { return this.pos >= this.buf.length; }
+        u8() { return this.buf[this.pos++]; }
+        u16() { const v = this.view.getUint16(this.pos, true); this.pos += 2; return v; }
+        u32() { const v = this.view.getUint32(this.pos, true); this.pos += 4; return v; }
+        i32() { const v = this.view.getInt32(this.pos, true); this.pos += 4; return v; }
+        f64() { const v = this.view.getFloat64(this.pos, true); this.pos += 8; return v; }
+        bytes(n) { const b = this.buf.subarray(this.pos, this.pos + n); this.pos += n; return b; }
+        str() { return new TextDecoder().decode(this.bytes(this.u16())); }
+    }
+
+    // Decodes a trace into its module name and a flat list of records.
+    function readTrace(bytes) {
+        const r = new Reader(bytes);
+        if (r.u32() !== MAGIC) throw new Error('not a wasm trace');
+        const version = r.u32();
+        if (version !== VERSION) throw new Error(`unsupported trace version ${version}`);
+        const module = r.str();
+        const records = [];
+        while (!r.done) {
+            const tag = r.u8();
+            switch (tag) {
+            case TAG_MALLOC: records.push({ tag: 'malloc', alloc: r.u32(), size: r.u32() }); break;
+            case TAG_FREE: records.push({ tag: 'free', alloc: r.u32() }); break;
+            case TAG_BLOB: {
+                const id = r.u32();
+                records.push({ tag: 'blob', blob: id, bytes: r.bytes(r.u32()) });
+                break;
+            }
+            case TAG_LOAD: records.push({ tag: 'load', alloc: r.u32(), blob: r.u32() }); break;
+            case TAG_CALL: {
+                const name = r.str();
+                const argc = r.u8();
+                const args = [];
+                for (let i = 0; i < argc; i++) {
+                    const kind = r.u8();
+                    if (kind === ARG_I32) args.push({ kind: 'i32', value: r.i32() });
+                    else if (kind === ARG_F64) args.push({ kind: 'f64', value: r.f64() });
+                    else if (kind === ARG_REF) args.push({ kind: 'ref', alloc: r.u32(), offset: r.u32() });
+                    else if (kind === ARG_UNRESOLVED) args.push({ kind: 'unresolved', value: r.u32() });
+                    else throw new Error(`bad argument kind ${kind}`);
+                }
+                records.push({ tag: 'call', name, args });
+                break;
+            }
+            default:
+                throw new Error(`bad record tag ${tag} at ${r.pos - 1}`);
+            }
+        }
+        return { module, records };
+    }
+
+    const api = { attachTrace, readTrace };
+    if (typeof exports === 'object' && typeof module === 'object') module.exports = api;
+    else self.WasmTrace = api;
+})();
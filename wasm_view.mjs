@@ -0,0 +1,130 @@
+// Typed view layer over a loaded wasm Module (game_logic or ground_renderer).
+//
+//   import { WasmView } from './wasm_view.mjs';
+//   const view = new WasmView(await createModule());
+//   view.setTexture(rgba, 256, 256);
+//   const frame = view.renderGround(1280, 720, camera);   // Uint8ClampedArray
+//   ctx.putImageData(new ImageData(frame, 1280, 720), 0, 0);
+//
+// Buffers in linear memory are allocated once per name and only reallocated
+// when a larger size is requested, so steady-state frames do no _malloc or
+// _free. Typed-array views are cached per buffer and type over the whole
+// capacity, and rebuilt only after a reallocation or heap growth (which
+// detaches the old ArrayBuffer); shorter requests get a subarray. Exports are called directly,
+// without ccall/cwrap argument marshalling.
+
+const VIEW_TYPES = {
+    u8: Uint8Array,
+    u8c: Uint8ClampedArray,
+    i32: Int32Array,
+    u32: Uint32Array,
+    f32: Float32Array,
+};
+
+export class WasmView {
+    constructor(Module) {
+        this.Module = Module;
+        this.buffers = new Map();   // name -> { ptr, capacity }
+        this.views = new Map();     // `${name}:${type}` -> typed array over the capacity
+        this.heap = null;
+    }
+
+    // Drops every cached view if the heap was replaced by memory growth.
+    refresh() {
+        const heap = this.Module.HEAPU8.buffer;
+        if (heap !== this.heap) {
+            this.heap = heap;
+            this.views.clear();
+        }
+        return heap;
+    }
+
+    // Returns the pointer of a persistent buffer of at least `bytes` bytes.
+    alloc(name, bytes) {
+        let buf = this.buffers.get(name);
+        if (buf && buf.capacity >= bytes) return buf.ptr;
+        if (buf) this.Module._free(buf.ptr);
+        const ptr = this.Module._malloc(bytes);
+        if (!ptr) throw new Error(`wasm allocation of ${bytes} bytes for "${name}" failed`);
+        buf = { ptr, capacity: bytes };
+        this.buffers.set(name, buf);
+        for (const type in VIEW_TYPES) this.views.delete(`${name}:${type}`);
+        return ptr;
+    }
+
+    ptr(name) {
+        const buf = this.buffers.get(name);
+        if (!buf) throw new Error(`no wasm buffer named "${name}"`);
+        return buf.ptr;
+    }
+
+    // Typed view over the first `bytes` bytes of a named buffer.
+    view(name, type, bytes) {
+        const heap = this.refresh();
+        const key = `${name}:${type}`;
+        const Ctor = VIEW_TYPES[type];
+        let v = this.views.get(key);
+        if (!v) {
+            const buf = this.buffers.get(name);
+            if (!buf) throw new Error(`no wasm buffer named "${name}"`);
+            v = new Ctor(heap, buf.ptr, Math.floor(buf.capacity / Ctor.BYTES_PER_ELEMENT));
+            this.views.set(key, v);
+        }
+        const length = bytes / Ctor.BYTES_PER_ELEMENT;
+        if (length > v.length) throw new RangeError(`"${name}" holds ${v.byteLength} bytes, ${bytes} requested`);
+        return length === v.length ? v : v.subarray(0, length);
+    }
+
+    // Copies an ArrayBuffer, typed array or DataView into a persistent
+    // buffer and returns its pointer.
+    upload(name, data) {
+        let src;
+        if (data instanceof ArrayBuffer ||
+            (typeof SharedArrayBuffer !== 'undefined' && data instanceof SharedArrayBuffer)) {
+            src = new Uint8Array(data);
+        } else if (ArrayBuffer.isView(data)) {
+            src = new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+        } else {
+            throw new TypeError(`upload("${name}") needs an ArrayBuffer or ArrayBuffer view`);
+        }
+        const ptr = this.alloc(name, src.byteLength);
+        this.view(name, 'u8', src.byteLength).set(src);
+        return ptr;
+    }
+
+    setTexture(pixels, width, height) {
+        const bytes = width * height * 4;
+        if (!(pixels && pixels.byteLength >= bytes)) {
+            throw new RangeError(`texture has ${pixels && pixels.byteLength} bytes, ` +
+                `${width}x${height} RGBA needs ${bytes}`);
+        }
+        this.upload('texture', pixels);
+        this.texWidth = width;
+        this.texHeight = height;
+    }
+
+    // Renders the ground into the persistent frame buffer and returns a view
+    // of it, valid until the next call that may grow the heap. `extra` is
+    // appended to the camera arguments (for _render_ground_performance).
+    renderGround(width, height, camera, kernel = '_render_ground_quality', extra = []) {
+        const bytes = width * height * 4;
+        const out = this.alloc('frame', bytes);
+        this.Module[kernel](out, this.ptr('texture'), width, height,
+            this.texWidth, this.texHeight,
+            camera.posX, camera.posY, camera.dirX, camera.dirY,
+            camera.planeX, camera.planeY, ...extra);
+        return this.view('frame', 'u8c', bytes);
+    }
+
+    // Uploads a packed obstacle batch in the layout _add_obstacles_batch
+    // already expects and adds it in one call.
+    addObstaclesBatch(data, count) {
+        return this.Module._add_obstacles_batch(this.upload('obstacles', data), count);
+    }
+
+    free() {
+        for (const buf of this.buffers.values()) this.Module._free(buf.ptr);
+        this.buffers.clear();
+        this.views.clear();
+    }
+}